@@ -39,6 +39,7 @@ SOURCES      := AS_global.C \
                 utility/system-stackTrace.C \
                 \
                 utility/sequence.C \
+                utility/sequence-2bit.C \
                 \
                 utility/kmers.C \
                 utility/kmers-reader.C \
@@ -74,6 +75,7 @@ SOURCES      := AS_global.C \
                 stores/ovStoreWriter.C \
                 stores/ovStoreFilter.C \
                 stores/ovStoreFile.C \
+                stores/ovStoreShared.C \
                 stores/ovStoreHistogram.C \
                 \
                 stores/tgStore.C \
@@ -107,6 +109,7 @@ SOURCES      := AS_global.C \
                 utgcns/libNDalign/NDalgorithm-reverse.C \
                 \
                 utgcns/libpbutgcns/AlnGraphBoost.C  \
+                utgcns/libpbutgcns/AlnGraphFlat.C  \
                 \
                 gfa/gfa.C \
                 gfa/bed.C
@@ -221,5 +224,9 @@ SUBMAKEFILES := stores/dumpBlob.mk \
 ifeq ($(BUILDTESTS), 1)
 SUBMAKEFILES += utility/bitsTest.mk \
                 utility/filesTest.mk \
-                utility/stddevTest.mk
+                utility/kmerLookupTest.mk \
+                utility/sequence2bitTest.mk \
+                utility/stddevTest.mk \
+                stores/sqStoreExtendTest.mk \
+                correction/falconConsensusMSATest.mk
 endif
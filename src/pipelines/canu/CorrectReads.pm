@@ -436,6 +436,7 @@ sub generateCorrectedReadsConfigure ($) {
     print F "\n";
     print F "bgnid=0\n";
     print F "endid=0\n";
+    print F "concurrent=1\n";
     print F "\n";
 
     my $nJobs = 0;
@@ -447,12 +448,15 @@ sub generateCorrectedReadsConfigure ($) {
         s/^\s+//;
         s/\s+$//;
 
-        my ($jobID, $bgnID, $endID, $nReads, $mem) = split '\s+', $_;
+        my ($jobID, $bgnID, $endID, $nReads, $mem, $nConc) = split '\s+', $_;
+
+        $nConc = 1   if (!defined($nConc));
 
         print  F "if [ \$jobid -eq $jobID ] ; then\n";
         printf F "  jobid=%04d\n", $jobID;   #  Parsed in Check() below.
         print  F "  bgnid=$bgnID\n";
         print  F "  endid=$endID\n";
+        print  F "  concurrent=$nConc\n";
         print  F "fi\n";
 
         $nJobs = $jobID;
@@ -514,6 +518,7 @@ sub generateCorrectedReadsConfigure ($) {
     print F "  -R ./$asm.readsToCorrect \\\n"                if ( fileExists("$path/$asm.readsToCorrect"));
     print F "  -r \$bgnid-\$endid \\\n";
     print F "  -t  " . getGlobal("corThreads") . " \\\n";
+    print F "  -concurrent \$concurrent \\\n";
     print F "  -cc " . getGlobal("corMinCoverage") . " \\\n";
     print F "  -cl " . getGlobal("minReadLength") . " \\\n";
     print F "  -oi " . getCorIdentity($asm) . " \\\n";
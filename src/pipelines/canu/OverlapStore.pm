@@ -387,6 +387,7 @@ sub createOverlapStoreParallel ($$$$$$) {
         print F "  -C  ./$asm.ovlStore.config \\\n";
         print F "  -f \\\n";
         print F "  -s \$jobid \\\n";
+        print F "  -threads " . getGlobal("ovsThreads") . " \\\n";
         print F "  -M $sortMemory \n";
         print F "\n";
 
@@ -251,6 +251,7 @@ sub createSequenceStore ($$@) {
         $cmd .= "$bin/sqStoreCreate \\\n";
         $cmd .= "  -o ./$asm.seqStore.BUILDING \\\n";
         $cmd .= "  -minlength "  . getGlobal("minReadLength")        . " \\\n";
+        $cmd .= "  -threads "    . getGlobal("executiveThreads")     . " \\\n";
         if (getGlobal("readSamplingCoverage") > 0) {
             $cmd .= "  -genomesize " . getGlobal("genomeSize")           . " \\\n";
             $cmd .= "  -coverage   " . getGlobal("readSamplingCoverage") . " \\\n";